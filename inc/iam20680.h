@@ -81,9 +81,14 @@ extern "C" {
 #define IAM20680_ZA_OFFSET_H        0x7D
 #define IAM20680_ZA_OFFSET_L        0x7E
 
-/**\name Status */
+/**\name Status, one bit per class so OR'd statuses keep every class seen */
 #define IAM20680_OK     0x00 /*< OK */
 #define IAM20680_ERR    0x01 /*< ERROR */
+#define IAM20680_E_BUS_NACK         0x02 /*< Bus transaction not acknowledged */
+#define IAM20680_E_BUS_TIMEOUT      0x04 /*< Bus transaction timed out */
+#define IAM20680_E_FIFO_OVERFLOW    0x08 /*< FIFO full, oldest data overwritten */
+#define IAM20680_E_FIFO_ALIGN       0x10 /*< FIFO head not on a frame boundary */
+#define IAM20680_E_RESET_TIMEOUT    0x20 /*< DEVICE_RESET did not clear */
  
 /**\name Who Am I */
 #define IAM20680_CHIP_ID    0xA9
@@ -92,6 +97,15 @@ extern "C" {
 #define IAM20680_SPI    0x00
 #define IAM20680_I2C    0x01
 
+/**\name FIFO */
+#define IAM20680_FIFO_SIZE          512 /*< FIFO depth in bytes */
+#define IAM20680_FIFO_FRAME_LEN     12  /*< Accel and gyro x, y, z two bytes each */
+#define IAM20680_FIFO_FRAMES_MAX    (IAM20680_FIFO_SIZE / IAM20680_FIFO_FRAME_LEN)
+
+/**\name Recovery */
+#define IAM20680_BUS_RETRY_MAX      3   /*< Retries of a NACK'd or timed out register transaction */
+#define IAM20680_RESET_POLL_MAX     10  /*< 1 ms polls for DEVICE_RESET to clear */
+
 /*****************************************************************************
  * TYPEDEFS
  ****************************************************************************/ 
@@ -108,7 +122,9 @@ extern "C" {
  * @param[in] len           : Number of bytes of data to be read.
  * 
  * @retval 0 -> Success.
- * @retval Non-zero -> Fail.
+ * @retval IAM20680_E_BUS_NACK -> Not acknowledged.
+ * @retval IAM20680_E_BUS_TIMEOUT -> Timed out.
+ * @retval Other non-zero -> Fail.
  */
 typedef uint8_t (*iam20680_read_fptr_typedef)(uint8_t reg_addr, uint8_t *reg_data, uint16_t len);
 
@@ -122,7 +138,9 @@ typedef uint8_t (*iam20680_read_fptr_typedef)(uint8_t reg_addr, uint8_t *reg_dat
  * @param[in] len           : Number of bytes of data to write.
  *
  * @retval 0 -> Success.
- * @retval Non-zero -> Fail.
+ * @retval IAM20680_E_BUS_NACK -> Not acknowledged.
+ * @retval IAM20680_E_BUS_TIMEOUT -> Timed out.
+ * @retval Other non-zero -> Fail.
  */
 typedef uint8_t (*iam20680_write_fptr_typedef)(uint8_t reg_addr, uint8_t *reg_data, uint16_t len);
 
@@ -155,7 +173,34 @@ struct iam20680_data {
  * @brief IAM-20680 register settings.
  */
 struct iam20680_settings {
-    
+    uint8_t smplrt_div;     /*< SMPLRT_DIV */
+    uint8_t config;         /*< CONFIG */
+    uint8_t gyro_config;    /*< GYRO_CONFIG */
+    uint8_t accel_config;   /*< ACCEL_CONFIG */
+    uint8_t accel_config2;  /*< ACCEL_CONFIG2 */
+    uint8_t lp_mode_cfg;    /*< LP_MODE_CFG */
+    uint8_t fifo_en;        /*< FIFO_EN */
+    uint8_t int_pin_cfg;    /*< INT_PIN_CFG */
+    uint8_t int_enable;     /*< INT_ENABLE */
+    uint8_t user_ctrl;      /*< USER_CTRL */
+    uint8_t pwr_mgmt_1;     /*< PWR_MGMT_1 */
+    uint8_t pwr_mgmt_2;     /*< PWR_MGMT_2 */
+    uint8_t valid;          /*< Non-zero once captured by an init API */
+};
+
+/**
+ * @brief IAM-20680 error recovery counters.
+ */
+struct iam20680_recovery_stats {
+    uint32_t bus_nacks;             /*< Bus attempts not acknowledged */
+    uint32_t bus_timeouts;          /*< Bus attempts timed out */
+    uint32_t bus_retries;           /*< Bus attempts retried after a NACK or timeout */
+    uint32_t bus_errors;            /*< Register transactions failed after retries */
+    uint32_t fifo_overflows;        /*< FIFO overflows detected */
+    uint32_t fifo_misalignments;    /*< FIFO frame misalignments detected */
+    uint32_t fifo_resyncs;          /*< FIFO realigned by discarding a partial frame */
+    uint32_t fifo_resets;           /*< FIFO reset without device reset */
+    uint32_t full_resets;           /*< Device reset and re-initialized */
 };
 
 /**
@@ -166,9 +211,10 @@ struct iam20680_dev {
     iam20680_write_fptr_typedef write;  /*< Write function pointer */
     iam20680_delay_fptr_typedef delay;  /*< Delay function pointer */
     uint8_t interface;                  /*< Interface type (I2C, SPI) */
-    struct iam20680_settings settings;  /*< Sensor settings */
+    struct iam20680_settings settings;  /*< Configuration captured by the init APIs */
     uint8_t status;                     /*< Returned status of read/write functions */
     uint8_t chip_id;                    /*< Chip ID */
+    struct iam20680_recovery_stats recovery; /*< Error recovery counters */
 };
 
 
@@ -321,6 +367,106 @@ uint8_t iam20680_delay_ms(uint32_t delay, struct iam20680_dev *dev);
  */
 uint8_t iam20680_get_data(struct iam20680_data *data, struct iam20680_dev *dev);
 
+/*!
+ * \ingroup iam20680ApiRegister
+ * \page iam20680_api_iam20680_get_fifo_count iam20680_get_fifo_count
+ * \code
+ * uint8_t iam20680_get_fifo_count(uint16_t *count, struct iam20680_dev *dev);
+ * \endcode
+ * @details This API gets the number of bytes currently stored in the FIFO
+ *
+ * @param[out] count    : Number of bytes in the FIFO.
+ * @param[in, out]      : Structure instance of iam20680_dev.
+ *
+ * @regurn Result of API execution status.
+ *
+ * @retval 0 -> Success.
+ * @retvan Non-zero -> Fail. 
+ *
+ */
+uint8_t iam20680_get_fifo_count(uint16_t *count, struct iam20680_dev *dev);
+
+/*!
+ * \ingroup iam20680ApiRegister
+ * \page iam20680_api_iam20680_get_fifo_data iam20680_get_fifo_data
+ * \code
+ * uint8_t iam20680_get_fifo_data(struct iam20680_data *data, uint16_t *n_frames, struct iam20680_dev *dev);
+ * \endcode
+ * @details This API drains whole accelerometer and gyrometer frames from the
+ * FIFO as configured by iam20680_init. Temperature is not stored in the FIFO
+ * and is set to zero. FIFO faults are reported for iam20680_recover. Overflow
+ * is detected from FIFO_OFLOW_INT, reading INT_STATUS clears all its flags.
+ *
+ * @param[out] data         : Array to store the decoded frames.
+ * @param[in, out] n_frames : Capacity of data on input, number of frames read on output.
+ * @param[in, out]          : Structure instance of iam20680_dev.
+ *
+ * @regurn Result of API execution status.
+ *
+ * @retval 0 -> Success.
+ * @retval IAM20680_E_FIFO_OVERFLOW -> FIFO overflowed, nothing read.
+ * @retval IAM20680_E_FIFO_ALIGN -> FIFO head misaligned, nothing read.
+ * @retvan Non-zero -> Fail. 
+ *
+ */
+uint8_t iam20680_get_fifo_data(struct iam20680_data *data, uint16_t *n_frames, struct iam20680_dev *dev);
+
+/**
+ * \ingroup iam20680
+ * \defgroup iam20680ApiRecovery Recovery
+ * @brief Recover from bus errors and FIFO faults
+ */
+
+/*!
+ * \ingroup iam20680ApiRecovery
+ * \page iam20680_api_iam20680_recover iam20680_recover
+ * \code
+ * uint8_t iam20680_recover(uint8_t error, struct iam20680_dev *dev);
+ * \endcode
+ * @details This API recovers from an error returned by another API using the
+ * cheapest fix for its class and escalating only if that fix fails:
+ * realign the FIFO on a frame boundary for misalignment and bus errors,
+ * then reset the FIFO, e.g. when it is full; reset the FIFO for overflow.
+ * NACKs and timeouts are already retried by iam20680_read_regs and
+ * iam20680_write_regs. Only these fixes run here, none of them delays; if
+ * they fail the caller should schedule iam20680_reinit where blocking for
+ * over 100 ms is acceptable.
+ *
+ * @param[in] error     : Status returned by the failed API.
+ * @param[in, out]      : Structure instance of iam20680_dev.
+ *
+ * @regurn Result of API execution status.
+ *
+ * @retval 0 -> Success.
+ * @retvan Non-zero -> Fail, iam20680_reinit is required. 
+ *
+ */
+uint8_t iam20680_recover(uint8_t error, struct iam20680_dev *dev);
+
+/*!
+ * \ingroup iam20680ApiRecovery
+ * \page iam20680_api_iam20680_reinit iam20680_reinit
+ * \code
+ * uint8_t iam20680_reinit(struct iam20680_dev *dev);
+ * \endcode
+ * @details This API resets the device, disables I2C when on SPI, wakes it
+ * with CLKSEL set and replays the configuration captured at the end of the
+ * last successful iam20680_init, iam20680_init2 or iam20680_init_simple
+ * call: sample rate, filters, full scale ranges, low power mode, interrupt
+ * pin and enables, sensor enables, FIFO enables and USER_CTRL. The FIFO is
+ * reset and starts empty. Blocks for over 100 ms.
+ *
+ * @param[in, out]      : Structure instance of iam20680_dev.
+ *
+ * @regurn Result of API execution status.
+ *
+ * @retval 0 -> Success.
+ * @retval IAM20680_ERR -> No configuration captured yet.
+ * @retvan Non-zero -> Fail. 
+ *
+ */
+uint8_t iam20680_reinit(struct iam20680_dev *dev);
+
 
 #ifdef __cplusplus
 }
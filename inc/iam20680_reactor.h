@@ -0,0 +1,251 @@
+/**
+ * @file    iam20680_reactor.h
+ * @date    18Oct2026
+ * @brief   This is the header file for the Linux epoll reactor servicing
+ *          multiple TDK IAM-20680 acceleromter/gyrometers from one thread.
+ */
+
+#ifndef __IAM20680_REACTOR_H
+#define __IAM20680_REACTOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * INCLUDES
+ ****************************************************************************/
+/**
+ * @brief Required includes
+ */
+#include <stdint.h>
+#include "iam20680.h"
+
+/*****************************************************************************
+ * MACROS AND DEFINES
+ ****************************************************************************/
+/**\name Reactor limits */
+#define IAM20680_REACTOR_MAX_SENSORS    64  /*< Sensors per reactor */
+#define IAM20680_REACTOR_DRAIN_PASSES   2   /*< FIFO batches per sensor per iam20680_reactor_run_once */
+
+/*****************************************************************************
+ * TYPEDEFS
+ ****************************************************************************/
+/**
+ * @brief Type definitions
+ */
+
+/**
+ * @brief Batch callback function pointer. Called from the reactor thread with
+ * the frames drained from a sensor FIFO after its interrupt fired.
+ *
+ * @param[in] dev           : Sensor the frames were drained from.
+ * @param[in] data          : Drained frames, valid only for the duration of the call.
+ * @param[in] n_frames      : Number of frames in data.
+ * @param[in] user_data     : User pointer given at registration.
+ */
+typedef void (*iam20680_reactor_cb_typedef)(struct iam20680_dev *dev, struct iam20680_data *data,
+                                            uint16_t n_frames, void *user_data);
+
+/**
+ * @brief Fault callback function pointer. Called from the reactor thread when
+ * a sensor FIFO could not be drained and iam20680_recover could not fix it.
+ * The sensor is parked, it is no longer drained until
+ * iam20680_reactor_clear_fault is called, typically after iam20680_reinit
+ * ran on another thread.
+ *
+ * @param[in] dev           : Faulted sensor.
+ * @param[in] error         : Status of the failed drain.
+ * @param[in] user_data     : User pointer given at registration.
+ */
+typedef void (*iam20680_reactor_fault_cb_typedef)(struct iam20680_dev *dev, uint8_t error, void *user_data);
+
+/**
+ * @brief Sensor registered on a reactor.
+ */
+struct iam20680_reactor_sensor {
+    struct iam20680_dev *dev;               /*< Sensor, NULL if slot is free */
+    int fd;                                 /*< Interrupt file descriptor */
+    iam20680_reactor_cb_typedef callback;   /*< Batch callback */
+    void *user_data;                        /*< User pointer passed to callback */
+    uint8_t pending;                        /*< Interrupt seen, FIFO not yet drained */
+    uint8_t fault;                          /*< Parked, accessed with __atomic builtins */
+};
+
+/**
+ * @brief IAM-20680 reactor parameters.
+ */
+struct iam20680_reactor {
+    int epoll_fd;                                                       /*< epoll instance */
+    int wake_fd;                                                        /*< eventfd used to interrupt the loop */
+    uint32_t coalesce_ms;                                               /*< Interrupt coalescing window in ms */
+    uint8_t running;                                                    /*< Cleared by iam20680_reactor_stop, atomic */
+    iam20680_reactor_fault_cb_typedef fault_callback;                   /*< Fault callback */
+    struct iam20680_reactor_sensor sensors[IAM20680_REACTOR_MAX_SENSORS]; /*< Registered sensors */
+    struct iam20680_data batch[IAM20680_FIFO_FRAMES_MAX];               /*< Drain buffer */
+};
+
+
+/*****************************************************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ****************************************************************************/
+/**
+ * \ingroup iam20680
+ * \defgroup iam20680ApiReactor Reactor
+ * @brief Service interrupts from multiple sensors on one epoll loop
+ */
+
+/*!
+ * \ingroup iam20680ApiReactor
+ * \page iam20680_api_iam20680_reactor_init iam20680_reactor_init
+ * \code
+ * uint8_t iam20680_reactor_init(struct iam20680_reactor *reactor, uint32_t coalesce_ms,
+ *                               iam20680_reactor_fault_cb_typedef fault_callback);
+ * \endcode
+ * @details This API creates the epoll instance. Interrupts arriving within
+ * coalesce_ms of the first one are collected before any FIFO is drained, so
+ * each sensor is drained once per window. A window of 0 drains immediately.
+ * Sensors whose FIFO cannot be read are parked and reported to fault_callback.
+ *
+ * @param[out] reactor      : Structure instance of iam20680_reactor.
+ * @param[in] coalesce_ms   : Interrupt coalescing window in ms.
+ * @param[in] fault_callback : Fault callback, required.
+ *
+ * @retval 0 -> Success.
+ * @retval Non-zero -> Fail.
+ */
+uint8_t iam20680_reactor_init(struct iam20680_reactor *reactor, uint32_t coalesce_ms,
+                              iam20680_reactor_fault_cb_typedef fault_callback);
+
+/*!
+ * \ingroup iam20680ApiReactor
+ * \page iam20680_api_iam20680_reactor_deinit iam20680_reactor_deinit
+ * \code
+ * uint8_t iam20680_reactor_deinit(struct iam20680_reactor *reactor);
+ * \endcode
+ * @details This API closes the epoll instance. Interrupt file descriptors are
+ * owned by the caller and are not closed.
+ *
+ * @param[in, out] reactor  : Structure instance of iam20680_reactor.
+ *
+ * @retval 0 -> Success.
+ * @retval Non-zero -> Fail.
+ */
+uint8_t iam20680_reactor_deinit(struct iam20680_reactor *reactor);
+
+/*!
+ * \ingroup iam20680ApiReactor
+ * \page iam20680_api_iam20680_reactor_add iam20680_reactor_add
+ * \code
+ * uint8_t iam20680_reactor_add(struct iam20680_reactor *reactor, struct iam20680_dev *dev, int fd,
+ *                              iam20680_reactor_cb_typedef callback, void *user_data);
+ * \endcode
+ * @details This API registers a sensor initialized with iam20680_init. fd is
+ * its data ready interrupt, either a GPIO line event fd or an eventfd, and is
+ * switched to non-blocking mode. A sensor can be registered once.
+ *
+ * @param[in, out] reactor  : Structure instance of iam20680_reactor.
+ * @param[in] dev           : Structure instance of iam20680_dev.
+ * @param[in] fd            : Interrupt file descriptor.
+ * @param[in] callback      : Batch callback.
+ * @param[in] user_data     : User pointer passed to callback.
+ *
+ * @retval 0 -> Success.
+ * @retval Non-zero -> Fail.
+ */
+uint8_t iam20680_reactor_add(struct iam20680_reactor *reactor, struct iam20680_dev *dev, int fd,
+                             iam20680_reactor_cb_typedef callback, void *user_data);
+
+/*!
+ * \ingroup iam20680ApiReactor
+ * \page iam20680_api_iam20680_reactor_remove iam20680_reactor_remove
+ * \code
+ * uint8_t iam20680_reactor_remove(struct iam20680_reactor *reactor, struct iam20680_dev *dev);
+ * \endcode
+ * @details This API unregisters a sensor. It must be called from the reactor
+ * thread or while the reactor is not running.
+ *
+ * @param[in, out] reactor  : Structure instance of iam20680_reactor.
+ * @param[in] dev           : Structure instance of iam20680_dev.
+ *
+ * @retval 0 -> Success.
+ * @retval Non-zero -> Fail.
+ */
+uint8_t iam20680_reactor_remove(struct iam20680_reactor *reactor, struct iam20680_dev *dev);
+
+/*!
+ * \ingroup iam20680ApiReactor
+ * \page iam20680_api_iam20680_reactor_clear_fault iam20680_reactor_clear_fault
+ * \code
+ * uint8_t iam20680_reactor_clear_fault(struct iam20680_reactor *reactor, struct iam20680_dev *dev);
+ * \endcode
+ * @details This API resumes draining a parked sensor on its next interrupt.
+ * It may be called from another thread, e.g. once the sensor was
+ * reinitialized, but not concurrently with iam20680_reactor_remove.
+ *
+ * @param[in, out] reactor  : Structure instance of iam20680_reactor.
+ * @param[in] dev           : Structure instance of iam20680_dev.
+ *
+ * @retval 0 -> Success.
+ * @retval Non-zero -> Fail.
+ */
+uint8_t iam20680_reactor_clear_fault(struct iam20680_reactor *reactor, struct iam20680_dev *dev);
+
+/*!
+ * \ingroup iam20680ApiReactor
+ * \page iam20680_api_iam20680_reactor_run_once iam20680_reactor_run_once
+ * \code
+ * uint8_t iam20680_reactor_run_once(struct iam20680_reactor *reactor, int timeout_ms);
+ * \endcode
+ * @details This API waits up to timeout_ms for interrupts, coalesces them and
+ * dispatches the drained FIFO batches. FIFO and bus faults are passed to
+ * iam20680_recover, sensors it cannot fix are parked and reported to the
+ * fault callback. A timeout of -1 waits forever.
+ *
+ * @param[in, out] reactor  : Structure instance of iam20680_reactor.
+ * @param[in] timeout_ms    : Wait timeout in ms.
+ *
+ * @retval 0 -> Success.
+ * @retval Non-zero -> Fail.
+ */
+uint8_t iam20680_reactor_run_once(struct iam20680_reactor *reactor, int timeout_ms);
+
+/*!
+ * \ingroup iam20680ApiReactor
+ * \page iam20680_api_iam20680_reactor_run iam20680_reactor_run
+ * \code
+ * uint8_t iam20680_reactor_run(struct iam20680_reactor *reactor);
+ * \endcode
+ * @details This API runs the loop until iam20680_reactor_stop is called. It
+ * returns at once if the reactor was stopped before, a stopped reactor stays
+ * stopped until iam20680_reactor_init.
+ *
+ * @param[in, out] reactor  : Structure instance of iam20680_reactor.
+ *
+ * @retval 0 -> Success.
+ * @retval Non-zero -> Fail.
+ */
+uint8_t iam20680_reactor_run(struct iam20680_reactor *reactor);
+
+/*!
+ * \ingroup iam20680ApiReactor
+ * \page iam20680_api_iam20680_reactor_stop iam20680_reactor_stop
+ * \code
+ * uint8_t iam20680_reactor_stop(struct iam20680_reactor *reactor);
+ * \endcode
+ * @details This API stops iam20680_reactor_run. It may be called from a
+ * callback or from another thread, before or while the loop runs.
+ *
+ * @param[in, out] reactor  : Structure instance of iam20680_reactor.
+ *
+ * @retval 0 -> Success.
+ * @retval Non-zero -> Fail.
+ */
+uint8_t iam20680_reactor_stop(struct iam20680_reactor *reactor);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IAM20680_REACTOR_H */
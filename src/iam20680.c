@@ -11,11 +11,181 @@
 #include "iam20680.h"
 
 /**\name Internal macros */
+#define IAM20680_FIFO_BURST_FRAMES  (255 / IAM20680_FIFO_FRAME_LEN)   /*< Frames per FIFO burst read */
 
 /**\name Internal APIs */
 
 // Ex: power modes, calibration checks, etc
 
+/*!
+ * @brief This internal API runs one bus transaction, retrying NACKs and
+ * timeouts. Other failures are not known to be transient and are not retried.
+ */
+static uint8_t bus_transfer(iam20680_read_fptr_typedef xfer, uint8_t reg_addr, uint8_t *reg_data, uint8_t len,
+                            uint8_t retries, struct iam20680_dev *dev)
+{
+    uint8_t status;
+    uint8_t retry = 0;
+
+    for (;;)
+    {
+        status = xfer(reg_addr, reg_data, len);
+        if (status == IAM20680_E_BUS_NACK)
+        {
+            dev->recovery.bus_nacks++;
+        }
+        else if (status == IAM20680_E_BUS_TIMEOUT)
+        {
+            dev->recovery.bus_timeouts++;
+        }
+        else
+        {
+            break;
+        }
+
+        if (retry++ == retries)
+        {
+            break;
+        }
+        dev->recovery.bus_retries++;
+    }
+
+    if (status != IAM20680_OK)
+    {
+        dev->recovery.bus_errors++;
+    }
+
+    return status;
+}
+
+/*!
+ * @brief This internal API captures the configuration registers written by
+ * the init APIs so iam20680_reinit can replay them. After a failed init or
+ * capture the previous configuration is kept.
+ */
+static uint8_t settings_save(uint8_t init_status, struct iam20680_dev *dev)
+{
+    struct iam20680_settings settings;
+    uint8_t status;
+
+    if (init_status != IAM20680_OK)
+    {
+        return init_status;
+    }
+
+    status = iam20680_read_regs((uint8_t)IAM20680_SMPLRT_DIV, &settings.smplrt_div, 1, dev);
+    status |= iam20680_read_regs((uint8_t)IAM20680_CONFIG, &settings.config, 1, dev);
+    status |= iam20680_read_regs((uint8_t)IAM20680_GYRO_CONFIG, &settings.gyro_config, 1, dev);
+    status |= iam20680_read_regs((uint8_t)IAM20680_ACCEL_CONFIG, &settings.accel_config, 1, dev);
+    status |= iam20680_read_regs((uint8_t)IAM20680_ACCEL_CONFIG2, &settings.accel_config2, 1, dev);
+    status |= iam20680_read_regs((uint8_t)IAM20680_LP_MODE_CFG, &settings.lp_mode_cfg, 1, dev);
+    status |= iam20680_read_regs((uint8_t)IAM20680_FIFO_EN, &settings.fifo_en, 1, dev);
+    status |= iam20680_read_regs((uint8_t)IAM20680_INT_PIN_CFG, &settings.int_pin_cfg, 1, dev);
+    status |= iam20680_read_regs((uint8_t)IAM20680_INT_ENABLE, &settings.int_enable, 1, dev);
+    status |= iam20680_read_regs((uint8_t)IAM20680_USER_CTRL, &settings.user_ctrl, 1, dev);
+    status |= iam20680_read_regs((uint8_t)IAM20680_PWR_MGMT_1, &settings.pwr_mgmt_1, 1, dev);
+    status |= iam20680_read_regs((uint8_t)IAM20680_PWR_MGMT_2, &settings.pwr_mgmt_2, 1, dev);
+    if (status == IAM20680_OK)
+    {
+        settings.valid = 1;
+        dev->settings = settings;
+    }
+
+    return status;
+}
+
+/*!
+ * @brief This internal API resets the device and waits, bounded, for
+ * DEVICE_RESET to clear.
+ */
+static uint8_t device_reset(struct iam20680_dev *dev)
+{
+    uint8_t status;
+    uint8_t buff = 0x00;
+    uint8_t polls = 0;
+
+    status = iam20680_read_regs((uint8_t)IAM20680_PWR_MGMT_1, &buff, 1, dev);
+    buff |= 0x80; // DEVICE_RESET
+    status |= iam20680_write_regs((uint8_t)IAM20680_PWR_MGMT_1, &buff, 1, dev);
+    if (status != IAM20680_OK)
+    {
+        return status;
+    }
+    iam20680_delay_ms(100, dev);
+
+    // Reads may fail while the device comes back, keep polling until the bound.
+    do
+    {
+        status = iam20680_read_regs((uint8_t)IAM20680_PWR_MGMT_1, &buff, 1, dev);
+        if (status == IAM20680_OK && (buff & 0x80) == 0x00)
+        {
+            return IAM20680_OK;
+        }
+        iam20680_delay_ms(1, dev);
+    } while (++polls < IAM20680_RESET_POLL_MAX);
+
+    return IAM20680_E_RESET_TIMEOUT;
+}
+
+/*!
+ * @brief This internal API discards the partial frame at the FIFO head so
+ * the next read starts on a frame boundary.
+ */
+static uint8_t fifo_resync(struct iam20680_dev *dev)
+{
+    uint8_t buff[IAM20680_FIFO_FRAME_LEN];
+    uint16_t count = 0;
+    uint8_t status;
+
+    status = iam20680_get_fifo_count(&count, dev);
+    if (status != IAM20680_OK || count >= IAM20680_FIFO_SIZE)
+    {
+        return IAM20680_ERR;
+    }
+
+    // FIFO holds whole frames, so the residue is what is left of the head frame.
+    count %= IAM20680_FIFO_FRAME_LEN;
+    if (count > 0)
+    {
+        status = iam20680_read_regs((uint8_t)IAM20680_FIFO_R_W, &buff[0], count, dev);
+        if (status == IAM20680_OK)
+        {
+            dev->recovery.fifo_resyncs++;
+        }
+    }
+
+    return status;
+}
+
+/*!
+ * @brief This internal API resets the FIFO, leaving its configuration intact.
+ */
+static uint8_t fifo_reset(struct iam20680_dev *dev)
+{
+    uint8_t status;
+    uint8_t buff = 0x00;
+    uint8_t fifo_en;
+
+    status = iam20680_read_regs((uint8_t)IAM20680_USER_CTRL, &buff, 1, dev);
+    if (status != IAM20680_OK)
+    {
+        return status;
+    }
+    fifo_en = buff & 0x40;
+    buff &= ~0x40;      // FIFO_EN
+    buff |= 1 << 2;     // FIFO_RST
+    status = iam20680_write_regs((uint8_t)IAM20680_USER_CTRL, &buff, 1, dev);
+    buff &= ~0x04;      // FIFO_RST self-clears
+    buff |= fifo_en;    // FIFO_EN as it was
+    status |= iam20680_write_regs((uint8_t)IAM20680_USER_CTRL, &buff, 1, dev);
+    if (status == IAM20680_OK)
+    {
+        dev->recovery.fifo_resets++;
+    }
+
+    return status;
+}
+
 /*!
  * @brief This API must be called before other APIs. It verifies the chip ID of the sensor.
  */
@@ -171,7 +341,10 @@ uint8_t iam20680_init(struct iam20680_dev *dev)
     buff &= ~0x40;
     buff |= 1 << 6;     // FIFO_EN
     status |= iam20680_write_regs((uint8_t)IAM20680_USER_CTRL, &buff, 1, dev);
-  
+
+    // Capture configuration for iam20680_reinit.
+    status = settings_save(status, dev);
+
     return status;
 }
 
@@ -192,20 +365,11 @@ uint8_t iam20680_init2(struct iam20680_dev *dev)
     status |= iam20680_write_regs((uint8_t)IAM20680_USER_CTRL, &buff, 1, dev);
 
     // Check WHO_AM_I register.
-    status = iam20680_read_regs((uint8_t)IAM20680_WHO_AM_I, &buff, 1, dev);
+    status |= iam20680_read_regs((uint8_t)IAM20680_WHO_AM_I, &buff, 1, dev);
     dev->chip_id = buff;
     
     // Reset driver states.
-    status |= iam20680_read_regs((uint8_t)IAM20680_PWR_MGMT_1, &buff, 1, dev);
-    buff |= 0x80; // DEVICE_RESET
-    status |= iam20680_write_regs((uint8_t)IAM20680_PWR_MGMT_1, &buff, 1, dev);
-    iam20680_delay_ms(100, dev);
-    //buff = 0x00;
-    while ((buff & (0x80)) != 0x00)
-    {
-        iam20680_read_regs((uint8_t)IAM20680_PWR_MGMT_1, &buff, 1, dev);
-        iam20680_delay_ms(1, dev);
-    }
+    status |= device_reset(dev);
 
     // Disable I2C.
     status |= iam20680_read_regs((uint8_t)IAM20680_USER_CTRL, &buff, 1, dev);
@@ -235,7 +399,9 @@ uint8_t iam20680_init2(struct iam20680_dev *dev)
     // Configure FIFO.
     // Enable Data Ready interrupt.
 
-    
+    // Capture configuration for iam20680_reinit.
+    status = settings_save(status, dev);
+
     return status;    
 }
  
@@ -248,16 +414,7 @@ uint8_t iam20680_init_simple(struct iam20680_dev *dev)
     uint8_t status = 0x00;
 
     // Reset driver states.
-    status |= iam20680_read_regs((uint8_t)IAM20680_PWR_MGMT_1, &buff, 1, dev);
-    buff |= 0x80; // DEVICE_RESET
-    status |= iam20680_write_regs((uint8_t)IAM20680_PWR_MGMT_1, &buff, 1, dev);
-    iam20680_delay_ms(100, dev);
-    //buff = 0x00;
-    while ((buff & (0x80)) != 0x00)
-    {
-        iam20680_read_regs((uint8_t)IAM20680_PWR_MGMT_1, &buff, 1, dev);
-        iam20680_delay_ms(1, dev);
-    }
+    status |= device_reset(dev);
 
     // Let device select best clock source.
     buff = 0x00;
@@ -295,7 +452,9 @@ uint8_t iam20680_init_simple(struct iam20680_dev *dev)
     buff &= 0x07; 
     buff |= 5 << 0; 
     status |= iam20680_write_regs((uint8_t)IAM20680_CONFIG, &buff, 1, dev);
-    
+
+    // Capture configuration for iam20680_reinit.
+    status = settings_save(status, dev);
 
     return status;
 }
@@ -305,8 +464,8 @@ uint8_t iam20680_init_simple(struct iam20680_dev *dev)
  */
 uint8_t iam20680_write_regs(uint8_t reg_addr, uint8_t *reg_data, uint8_t len, struct iam20680_dev *dev)
 {
-	// Write the data.
-	dev->status = dev->write(reg_addr, reg_data, len);
+	// Write the data, retrying transient bus errors.
+	dev->status = bus_transfer(dev->write, reg_addr, reg_data, len, IAM20680_BUS_RETRY_MAX, dev);
 
 	return dev->status;
 }
@@ -316,14 +475,22 @@ uint8_t iam20680_write_regs(uint8_t reg_addr, uint8_t *reg_data, uint8_t len, st
  */
 uint8_t iam20680_read_regs(uint8_t reg_addr, uint8_t *reg_data, uint8_t len, struct iam20680_dev *dev)
 {
+    uint8_t retries = IAM20680_BUS_RETRY_MAX;
+
 	// Check if SPI is used.
 	if (dev->interface == IAM20680_SPI)
 	{
 		reg_addr |= 0x80;
 	}
 
+    // FIFO reads consume data, so a retry could return misaligned frames.
+    if ((reg_addr & 0x7F) == IAM20680_FIFO_R_W)
+    {
+        retries = 0;
+    }
+
 	// Read the data.
-    dev->status = dev->read(reg_addr, reg_data, len);
+    dev->status = bus_transfer(dev->read, reg_addr, reg_data, len, retries, dev);
 
 	return dev->status;
 }
@@ -358,3 +525,199 @@ uint8_t iam20680_get_data(struct iam20680_data *data, struct iam20680_dev *dev)
 
     return dev->status;
 }
+
+/*!
+ * @brief This api gets the number of bytes stored in the FIFO.
+ */
+uint8_t iam20680_get_fifo_count(uint16_t *count, struct iam20680_dev *dev)
+{
+    uint8_t buff[2] = {0};      // FIFO_COUNTH and FIFO_COUNTL.
+
+    dev->status = iam20680_read_regs((uint8_t)IAM20680_FIFO_COUNTH, &buff[0], sizeof(buff), dev);
+    *count = ((buff[0] & 0x1F) << 8) | buff[1];
+
+    return dev->status;
+}
+
+/*!
+ * @brief This api drains whole accelerometer and gyrometer frames from the FIFO.
+ */
+uint8_t iam20680_get_fifo_data(struct iam20680_data *data, uint16_t *n_frames, struct iam20680_dev *dev)
+{
+    uint8_t buff[IAM20680_FIFO_BURST_FRAMES * IAM20680_FIFO_FRAME_LEN];
+    uint16_t count = 0;
+    uint16_t frames;
+    uint16_t chunk;
+    uint16_t read = 0;
+    uint16_t i;
+    uint8_t *frame;
+    uint8_t int_status = 0x00;
+
+    // Reading INT_STATUS clears it, FIFO_OFLOW_INT stays set until then even
+    // if the count dropped below the FIFO depth since.
+    dev->status = iam20680_read_regs((uint8_t)IAM20680_INT_STATUS, &int_status, 1, dev);
+    dev->status |= iam20680_get_fifo_count(&count, dev);
+    if (dev->status != IAM20680_OK)
+    {
+        *n_frames = 0;
+        return dev->status;
+    }
+
+    // Full FIFO has overwritten its oldest data.
+    if ((int_status & 0x10) || count >= IAM20680_FIFO_SIZE)  // FIFO_OFLOW_INT
+    {
+        dev->recovery.fifo_overflows++;
+        *n_frames = 0;
+        dev->status = IAM20680_E_FIFO_OVERFLOW;
+        return dev->status;
+    }
+
+    // Frames are pushed whole, a residue means an earlier read was cut short.
+    if ((count % IAM20680_FIFO_FRAME_LEN) != 0)
+    {
+        dev->recovery.fifo_misalignments++;
+        *n_frames = 0;
+        dev->status = IAM20680_E_FIFO_ALIGN;
+        return dev->status;
+    }
+
+    frames = count / IAM20680_FIFO_FRAME_LEN;
+    if (frames > *n_frames)
+    {
+        frames = *n_frames;
+    }
+
+    while (read < frames)
+    {
+        // Burst length is limited to the 8-bit len of iam20680_read_regs.
+        chunk = frames - read;
+        if (chunk > IAM20680_FIFO_BURST_FRAMES)
+        {
+            chunk = IAM20680_FIFO_BURST_FRAMES;
+        }
+
+        dev->status = iam20680_read_regs((uint8_t)IAM20680_FIFO_R_W, &buff[0], chunk * IAM20680_FIFO_FRAME_LEN, dev);
+        if (dev->status != IAM20680_OK)
+        {
+            break;
+        }
+
+        for (i = 0; i < chunk; i++)
+        {
+            frame = &buff[i * IAM20680_FIFO_FRAME_LEN];
+            data[read + i].accel_x = (frame[0] << 8) | frame[1];
+            data[read + i].accel_y = (frame[2] << 8) | frame[3];
+            data[read + i].accel_z = (frame[4] << 8) | frame[5];
+            data[read + i].temp = 0;
+            data[read + i].gyro_x = (frame[6] << 8) | frame[7];
+            data[read + i].gyro_y = (frame[8] << 8) | frame[9];
+            data[read + i].gyro_z = (frame[10] << 8) | frame[11];
+        }
+        read += chunk;
+    }
+
+    *n_frames = read;
+
+    return dev->status;
+}
+
+/*!
+ * @brief This api recovers from an error with the cheapest fix for its class,
+ * leaving full resets to the caller.
+ */
+uint8_t iam20680_recover(uint8_t error, struct iam20680_dev *dev)
+{
+    uint8_t status = error;
+
+    // Classes are checked most severe first, error may carry several.
+    if (error == IAM20680_OK || (error & IAM20680_E_RESET_TIMEOUT))
+    {
+        // Nothing to do, or only iam20680_reinit can fix it.
+    }
+    else if (error & IAM20680_E_FIFO_OVERFLOW)
+    {
+        // Contents are unusable, drop them.
+        status = fifo_reset(dev);
+    }
+    else
+    {
+        // Bus errors may have cut a FIFO burst short, leaving the head
+        // misaligned. A full FIFO cannot be realigned and is reset.
+        status = fifo_resync(dev);
+        if (status != IAM20680_OK)
+        {
+            status = fifo_reset(dev);
+        }
+    }
+
+    return status;
+}
+
+/*!
+ * @brief This api resets the device and restores the captured configuration.
+ */
+uint8_t iam20680_reinit(struct iam20680_dev *dev)
+{
+    struct iam20680_settings *settings = &dev->settings;
+    uint8_t status;
+    uint8_t buff;
+
+    if (!settings->valid)
+    {
+        return IAM20680_ERR;
+    }
+
+    status = device_reset(dev);
+    if (status != IAM20680_OK)
+    {
+        return status;
+    }
+
+    // Disable I2C.
+    if (dev->interface == IAM20680_SPI)
+    {
+        buff = 0x00;
+        status |= iam20680_read_regs((uint8_t)IAM20680_USER_CTRL, &buff, 1, dev);
+        buff |= 0x10;   // I2C_IF_DIS
+        status |= iam20680_write_regs((uint8_t)IAM20680_USER_CTRL, &buff, 1, dev);
+    }
+
+    // Wake up and set CLKSEL, DEVICE_RESET leaves SLEEP set.
+    buff = settings->pwr_mgmt_1;
+    buff &= ~0xC7;  // DEVICE_RESET, SLEEP, CLKSEL
+    buff |= 0x01;   // Set CLKSEL
+    status |= iam20680_write_regs((uint8_t)IAM20680_PWR_MGMT_1, &buff, 1, dev);
+    iam20680_delay_ms(5, dev);
+
+    // Replay configuration.
+    status |= iam20680_write_regs((uint8_t)IAM20680_SMPLRT_DIV, &settings->smplrt_div, 1, dev);
+    status |= iam20680_write_regs((uint8_t)IAM20680_CONFIG, &settings->config, 1, dev);
+    status |= iam20680_write_regs((uint8_t)IAM20680_GYRO_CONFIG, &settings->gyro_config, 1, dev);
+    status |= iam20680_write_regs((uint8_t)IAM20680_ACCEL_CONFIG, &settings->accel_config, 1, dev);
+    status |= iam20680_write_regs((uint8_t)IAM20680_ACCEL_CONFIG2, &settings->accel_config2, 1, dev);
+    status |= iam20680_write_regs((uint8_t)IAM20680_LP_MODE_CFG, &settings->lp_mode_cfg, 1, dev);
+    status |= iam20680_write_regs((uint8_t)IAM20680_INT_PIN_CFG, &settings->int_pin_cfg, 1, dev);
+    status |= iam20680_write_regs((uint8_t)IAM20680_INT_ENABLE, &settings->int_enable, 1, dev);
+    status |= iam20680_write_regs((uint8_t)IAM20680_PWR_MGMT_2, &settings->pwr_mgmt_2, 1, dev);
+    status |= iam20680_write_regs((uint8_t)IAM20680_FIFO_EN, &settings->fifo_en, 1, dev);
+
+    // Reset FIFO, then restore USER_CTRL.
+    buff = settings->user_ctrl;
+    if (dev->interface == IAM20680_SPI)
+    {
+        buff |= 0x10;   // I2C_IF_DIS
+    }
+    buff &= ~0x40;      // FIFO_EN
+    buff |= 1 << 2;     // FIFO_RST
+    status |= iam20680_write_regs((uint8_t)IAM20680_USER_CTRL, &buff, 1, dev);
+    buff &= ~0x04;      // FIFO_RST self-clears
+    buff |= settings->user_ctrl & 0x40;
+    status |= iam20680_write_regs((uint8_t)IAM20680_USER_CTRL, &buff, 1, dev);
+
+    if (status == IAM20680_OK)
+    {
+        dev->recovery.full_resets++;
+    }
+
+    return status;
+}
@@ -0,0 +1,426 @@
+/**
+ * @file    iam20680_reactor.c
+ * @date    18Oct2026
+ * @brief   This is the source file for the Linux epoll reactor servicing
+ *          multiple TDK IAM-20680 acceleromter/gyrometers from one thread.
+ */
+
+/*! @file iam20680_reactor.c
+ * @brief epoll reactor for IAM-20680 sensors
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "iam20680_reactor.h"
+
+/**\name Internal macros */
+#define IAM20680_REACTOR_MAX_EVENTS 16  /*< Events fetched per epoll_wait */
+#define IAM20680_REACTOR_ACK_LEN    64  /*< Holds an eventfd counter or a GPIO line event */
+
+/**\name Internal APIs */
+
+/*!
+ * @brief This internal API consumes every pending event on a non-blocking fd
+ * so level-triggered epoll does not report it again.
+ */
+static void reactor_ack(int fd)
+{
+    uint8_t buff[IAM20680_REACTOR_ACK_LEN];
+
+    while (read(fd, buff, sizeof(buff)) > 0)
+    {
+    }
+}
+
+/*!
+ * @brief This internal API acknowledges ready fds and marks their sensors pending.
+ */
+static uint8_t reactor_mark(struct iam20680_reactor *reactor, struct epoll_event *events, int n)
+{
+    struct iam20680_reactor_sensor *sensor;
+    uint8_t pending = 0;
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        sensor = events[i].data.ptr;
+        if (sensor == NULL)
+        {
+            reactor_ack(reactor->wake_fd);
+            continue;
+        }
+
+        reactor_ack(sensor->fd);
+        if (sensor->dev != NULL && !__atomic_load_n(&sensor->fault, __ATOMIC_ACQUIRE))
+        {
+            sensor->pending = 1;
+            pending = 1;
+        }
+    }
+
+    return pending;
+}
+
+/*!
+ * @brief This internal API returns the ms elapsed since start.
+ */
+static uint32_t reactor_elapsed_ms(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000);
+}
+
+/*!
+ * @brief This internal API parks a sensor and reports it to the fault callback.
+ */
+static void reactor_fault(struct iam20680_reactor *reactor, struct iam20680_reactor_sensor *sensor, uint8_t error)
+{
+    sensor->pending = 0;
+    __atomic_store_n(&sensor->fault, 1, __ATOMIC_RELEASE);
+    reactor->fault_callback(sensor->dev, error, sensor->user_data);
+}
+
+/*!
+ * @brief This internal API drains a sensor FIFO and dispatches it in batches.
+ * A failed drain is recovered once before the sensor is left for the next
+ * interrupt, a sensor iam20680_recover cannot fix is parked. A sensor still
+ * full after IAM20680_REACTOR_DRAIN_PASSES batches stays pending and is
+ * drained again after the other sensors.
+ */
+static void reactor_drain(struct iam20680_reactor *reactor, struct iam20680_reactor_sensor *sensor)
+{
+    uint16_t n_frames;
+    uint8_t recovered = 0;
+    uint8_t passes = 0;
+    uint8_t status;
+
+    sensor->pending = 0;
+
+    do
+    {
+        if (passes++ == IAM20680_REACTOR_DRAIN_PASSES)
+        {
+            sensor->pending = 1;
+            return;
+        }
+
+        n_frames = IAM20680_FIFO_FRAMES_MAX;
+        status = iam20680_get_fifo_data(reactor->batch, &n_frames, sensor->dev);
+
+        // Frames read before a failed burst are still valid.
+        if (n_frames > 0)
+        {
+            sensor->callback(sensor->dev, reactor->batch, n_frames, sensor->user_data);
+        }
+
+        // Callback may have removed the sensor.
+        if (sensor->dev == NULL)
+        {
+            return;
+        }
+
+        if (status != IAM20680_OK)
+        {
+            if (recovered)
+            {
+                return;
+            }
+            if (iam20680_recover(status, sensor->dev) != IAM20680_OK)
+            {
+                reactor_fault(reactor, sensor, status);
+                return;
+            }
+            recovered = 1;
+            n_frames = IAM20680_FIFO_FRAMES_MAX;
+        }
+    } while (n_frames == IAM20680_FIFO_FRAMES_MAX);
+}
+
+/*!
+ * @brief This API creates the epoll instance and its wake eventfd.
+ */
+uint8_t iam20680_reactor_init(struct iam20680_reactor *reactor, uint32_t coalesce_ms,
+                              iam20680_reactor_fault_cb_typedef fault_callback)
+{
+    struct epoll_event event = {0};
+    uint8_t i;
+
+    if (fault_callback == NULL)
+    {
+        return IAM20680_ERR;
+    }
+
+    for (i = 0; i < IAM20680_REACTOR_MAX_SENSORS; i++)
+    {
+        reactor->sensors[i].dev = NULL;
+        reactor->sensors[i].fd = -1;
+        reactor->sensors[i].pending = 0;
+        reactor->sensors[i].fault = 0;
+    }
+    reactor->coalesce_ms = coalesce_ms;
+    reactor->running = 1;
+    reactor->fault_callback = fault_callback;
+
+    reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (reactor->epoll_fd < 0)
+    {
+        return IAM20680_ERR;
+    }
+
+    reactor->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (reactor->wake_fd < 0)
+    {
+        close(reactor->epoll_fd);
+        return IAM20680_ERR;
+    }
+
+    // Wake fd is told apart from sensors by a NULL data pointer.
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, reactor->wake_fd, &event) != 0)
+    {
+        close(reactor->wake_fd);
+        close(reactor->epoll_fd);
+        return IAM20680_ERR;
+    }
+
+    return IAM20680_OK;
+}
+
+/*!
+ * @brief This API closes the epoll instance and its wake eventfd.
+ */
+uint8_t iam20680_reactor_deinit(struct iam20680_reactor *reactor)
+{
+    uint8_t status = IAM20680_OK;
+
+    if (close(reactor->wake_fd) != 0)
+    {
+        status = IAM20680_ERR;
+    }
+    if (close(reactor->epoll_fd) != 0)
+    {
+        status = IAM20680_ERR;
+    }
+
+    return status;
+}
+
+/*!
+ * @brief This API registers a sensor and its interrupt fd.
+ */
+uint8_t iam20680_reactor_add(struct iam20680_reactor *reactor, struct iam20680_dev *dev, int fd,
+                             iam20680_reactor_cb_typedef callback, void *user_data)
+{
+    struct iam20680_reactor_sensor *sensor = NULL;
+    struct epoll_event event = {0};
+    int flags;
+    uint8_t i;
+
+    if (dev == NULL || callback == NULL || fd < 0)
+    {
+        return IAM20680_ERR;
+    }
+
+    for (i = 0; i < IAM20680_REACTOR_MAX_SENSORS; i++)
+    {
+        if (reactor->sensors[i].dev == dev)
+        {
+            return IAM20680_ERR;
+        }
+        if (reactor->sensors[i].dev == NULL && sensor == NULL)
+        {
+            sensor = &reactor->sensors[i];
+        }
+    }
+    if (sensor == NULL)
+    {
+        return IAM20680_ERR;
+    }
+
+    // Acknowledging drains the fd until EAGAIN.
+    flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0)
+    {
+        return IAM20680_ERR;
+    }
+
+    event.events = EPOLLIN;
+    event.data.ptr = sensor;
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        return IAM20680_ERR;
+    }
+
+    sensor->dev = dev;
+    sensor->fd = fd;
+    sensor->callback = callback;
+    sensor->user_data = user_data;
+    sensor->pending = 0;
+    __atomic_store_n(&sensor->fault, 0, __ATOMIC_RELEASE);
+
+    return IAM20680_OK;
+}
+
+/*!
+ * @brief This API unregisters a sensor.
+ */
+uint8_t iam20680_reactor_remove(struct iam20680_reactor *reactor, struct iam20680_dev *dev)
+{
+    struct iam20680_reactor_sensor *sensor;
+    uint8_t i;
+
+    // A NULL dev would match a free slot.
+    if (dev == NULL)
+    {
+        return IAM20680_ERR;
+    }
+
+    for (i = 0; i < IAM20680_REACTOR_MAX_SENSORS; i++)
+    {
+        sensor = &reactor->sensors[i];
+        if (sensor->dev == dev)
+        {
+            epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, sensor->fd, NULL);
+            sensor->dev = NULL;
+            sensor->fd = -1;
+            sensor->pending = 0;
+            __atomic_store_n(&sensor->fault, 0, __ATOMIC_RELEASE);
+            return IAM20680_OK;
+        }
+    }
+
+    return IAM20680_ERR;
+}
+
+/*!
+ * @brief This API resumes draining a parked sensor.
+ */
+uint8_t iam20680_reactor_clear_fault(struct iam20680_reactor *reactor, struct iam20680_dev *dev)
+{
+    uint8_t i;
+
+    if (dev == NULL)
+    {
+        return IAM20680_ERR;
+    }
+
+    for (i = 0; i < IAM20680_REACTOR_MAX_SENSORS; i++)
+    {
+        if (reactor->sensors[i].dev == dev)
+        {
+            __atomic_store_n(&reactor->sensors[i].fault, 0, __ATOMIC_RELEASE);
+            return IAM20680_OK;
+        }
+    }
+
+    return IAM20680_ERR;
+}
+
+/*!
+ * @brief This API waits for interrupts, coalesces them and dispatches FIFO batches.
+ */
+uint8_t iam20680_reactor_run_once(struct iam20680_reactor *reactor, int timeout_ms)
+{
+    struct epoll_event events[IAM20680_REACTOR_MAX_EVENTS];
+    struct timespec start;
+    uint32_t elapsed;
+    uint8_t pending = 0;
+    uint8_t marked;
+    uint8_t i;
+    int n;
+
+    // Sensors left pending by the drain cap are serviced without waiting.
+    for (i = 0; i < IAM20680_REACTOR_MAX_SENSORS; i++)
+    {
+        pending |= reactor->sensors[i].pending;
+    }
+    if (pending)
+    {
+        timeout_ms = 0;
+    }
+
+    n = epoll_wait(reactor->epoll_fd, events, IAM20680_REACTOR_MAX_EVENTS, timeout_ms);
+    if (n < 0)
+    {
+        return (errno == EINTR) ? IAM20680_OK : IAM20680_ERR;
+    }
+
+    marked = reactor_mark(reactor, events, n);
+    if (marked == 0 && pending == 0)
+    {
+        return IAM20680_OK;
+    }
+
+    // Collect interrupts arriving within the window so each FIFO is drained
+    // once. Sensors left pending by the drain cap alone do not wait for it,
+    // and iam20680_reactor_stop ends it early.
+    if (reactor->coalesce_ms > 0 && marked)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        while (__atomic_load_n(&reactor->running, __ATOMIC_ACQUIRE) &&
+               (elapsed = reactor_elapsed_ms(&start)) < reactor->coalesce_ms)
+        {
+            n = epoll_wait(reactor->epoll_fd, events, IAM20680_REACTOR_MAX_EVENTS,
+                           (int)(reactor->coalesce_ms - elapsed));
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                break;
+            }
+            reactor_mark(reactor, events, n);
+        }
+    }
+
+    for (i = 0; i < IAM20680_REACTOR_MAX_SENSORS; i++)
+    {
+        if (reactor->sensors[i].pending)
+        {
+            reactor_drain(reactor, &reactor->sensors[i]);
+        }
+    }
+
+    return IAM20680_OK;
+}
+
+/*!
+ * @brief This API runs the loop until iam20680_reactor_stop is called.
+ */
+uint8_t iam20680_reactor_run(struct iam20680_reactor *reactor)
+{
+    uint8_t status = IAM20680_OK;
+
+    while (__atomic_load_n(&reactor->running, __ATOMIC_ACQUIRE) && status == IAM20680_OK)
+    {
+        status = iam20680_reactor_run_once(reactor, -1);
+    }
+
+    return status;
+}
+
+/*!
+ * @brief This API stops iam20680_reactor_run and wakes the loop.
+ */
+uint8_t iam20680_reactor_stop(struct iam20680_reactor *reactor)
+{
+    uint64_t one = 1;
+
+    __atomic_store_n(&reactor->running, 0, __ATOMIC_RELEASE);
+    if (write(reactor->wake_fd, &one, sizeof(one)) != sizeof(one))
+    {
+        return IAM20680_ERR;
+    }
+
+    return IAM20680_OK;
+}
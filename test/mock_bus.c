@@ -0,0 +1,198 @@
+/**
+ * @file    mock_bus.c
+ * @brief   Register-level IAM-20680 bus mock for the tests.
+ */
+
+#include <string.h>
+#include "mock_bus.h"
+
+int mock_failures;
+struct mock_sensor mock_sensors[MOCK_SENSORS];
+uint32_t mock_delay_total;
+
+/*!
+ * @brief Returns byte pos of the FIFO stream.
+ */
+static uint8_t mock_fifo_byte(uint32_t pos)
+{
+    uint32_t frame = pos / IAM20680_FIFO_FRAME_LEN;
+    uint8_t offset = pos % IAM20680_FIFO_FRAME_LEN;
+
+    if (offset == 0)
+    {
+        return (uint8_t)(frame >> 8);
+    }
+    if (offset == 1)
+    {
+        return (uint8_t)frame;
+    }
+
+    return offset;
+}
+
+/*!
+ * @brief Consumes an injected failure, if any.
+ */
+static uint8_t mock_inject(struct mock_sensor *mock)
+{
+    mock->transfers++;
+    if (mock->fail_count > 0)
+    {
+        mock->fail_count--;
+        return mock->fail_status;
+    }
+
+    return IAM20680_OK;
+}
+
+static uint8_t mock_read(struct mock_sensor *mock, uint8_t reg_addr, uint8_t *reg_data, uint16_t len)
+{
+    uint8_t status = mock_inject(mock);
+    uint16_t i;
+
+    if (status != IAM20680_OK)
+    {
+        return status;
+    }
+
+    reg_addr &= 0x7F;
+    if (reg_addr == IAM20680_FIFO_COUNTH)
+    {
+        reg_data[0] = (uint8_t)(mock->fifo_count >> 8);
+        reg_data[1] = (uint8_t)mock->fifo_count;
+        return IAM20680_OK;
+    }
+
+    if (reg_addr == IAM20680_FIFO_R_W)
+    {
+        mock->fifo_reads++;
+        for (i = 0; i < len; i++)
+        {
+            reg_data[i] = mock_fifo_byte(mock->fifo_pos + i);
+        }
+        mock->fifo_pos += len;
+        mock->fifo_count -= (len < mock->fifo_count) ? len : mock->fifo_count;
+        if (mock->refill > 0)
+        {
+            mock->refill--;
+            mock->fifo_count += len;
+        }
+        return IAM20680_OK;
+    }
+
+    if (reg_addr == IAM20680_INT_STATUS)
+    {
+        // Flags clear on read.
+        reg_data[0] = mock->regs[reg_addr];
+        mock->regs[reg_addr] = 0x00;
+        return IAM20680_OK;
+    }
+
+    if (reg_addr == IAM20680_PWR_MGMT_1 && mock->reset_pending > 0)
+    {
+        mock->reset_pending--;
+        reg_data[0] = mock->regs[reg_addr];
+        if (mock->reset_pending == 0)
+        {
+            mock->regs[reg_addr] &= ~0x80;
+        }
+        return IAM20680_OK;
+    }
+
+    for (i = 0; i < len; i++)
+    {
+        reg_data[i] = mock->regs[(reg_addr + i) & 0x7F];
+    }
+
+    return IAM20680_OK;
+}
+
+static uint8_t mock_write(struct mock_sensor *mock, uint8_t reg_addr, uint8_t *reg_data, uint16_t len)
+{
+    uint8_t status = mock_inject(mock);
+
+    (void)len;
+    if (status != IAM20680_OK)
+    {
+        return status;
+    }
+
+    reg_addr &= 0x7F;
+    if (reg_addr == IAM20680_PWR_MGMT_1 && (reg_data[0] & 0x80))
+    {
+        // Registers return to defaults, the device comes back asleep.
+        memset(mock->regs, 0, sizeof(mock->regs));
+        mock->regs[IAM20680_PWR_MGMT_1] = 0x41;
+        mock->regs[IAM20680_WHO_AM_I] = IAM20680_CHIP_ID;
+        mock->fifo_count = 0;
+        mock->fifo_pos = 0;
+        mock->resets++;
+        if (mock->reset_polls > 0)
+        {
+            mock->regs[IAM20680_PWR_MGMT_1] |= 0x80;
+            mock->reset_pending = mock->reset_polls;
+        }
+        return IAM20680_OK;
+    }
+
+    if (reg_addr == IAM20680_USER_CTRL && (reg_data[0] & 0x04))
+    {
+        mock->fifo_count = 0;
+        mock->fifo_pos = 0;
+    }
+
+    mock->regs[reg_addr] = reg_data[0] & ((reg_addr == IAM20680_USER_CTRL) ? ~0x04 : 0xFF);
+
+    return IAM20680_OK;
+}
+
+static uint8_t mock_read0(uint8_t reg_addr, uint8_t *reg_data, uint16_t len)
+{
+    return mock_read(&mock_sensors[0], reg_addr, reg_data, len);
+}
+
+static uint8_t mock_read1(uint8_t reg_addr, uint8_t *reg_data, uint16_t len)
+{
+    return mock_read(&mock_sensors[1], reg_addr, reg_data, len);
+}
+
+static uint8_t mock_write0(uint8_t reg_addr, uint8_t *reg_data, uint16_t len)
+{
+    return mock_write(&mock_sensors[0], reg_addr, reg_data, len);
+}
+
+static uint8_t mock_write1(uint8_t reg_addr, uint8_t *reg_data, uint16_t len)
+{
+    return mock_write(&mock_sensors[1], reg_addr, reg_data, len);
+}
+
+static void mock_delay(uint32_t delay)
+{
+    mock_delay_total += delay;
+}
+
+void mock_bind(struct iam20680_dev *dev, uint8_t idx, uint8_t interface)
+{
+    struct mock_sensor *mock = &mock_sensors[idx];
+
+    memset(mock, 0, sizeof(*mock));
+    mock->regs[IAM20680_PWR_MGMT_1] = 0x41;
+    mock->regs[IAM20680_WHO_AM_I] = IAM20680_CHIP_ID;
+
+    memset(dev, 0, sizeof(*dev));
+    dev->read = (idx == 0) ? mock_read0 : mock_read1;
+    dev->write = (idx == 0) ? mock_write0 : mock_write1;
+    dev->delay = mock_delay;
+    dev->interface = interface;
+}
+
+void mock_fill_fifo(uint8_t idx, uint16_t frames)
+{
+    mock_sensors[idx].fifo_count += frames * IAM20680_FIFO_FRAME_LEN;
+}
+
+void mock_fail(uint8_t idx, uint8_t status, uint32_t count)
+{
+    mock_sensors[idx].fail_status = status;
+    mock_sensors[idx].fail_count = count;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file    mock_bus.h
+ * @brief   Register-level IAM-20680 bus mock and check helpers for the tests.
+ */
+
+#ifndef __MOCK_BUS_H
+#define __MOCK_BUS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "iam20680.h"
+
+/**\name Mock limits */
+#define MOCK_SENSORS    2   /*< Sensors with their own bus functions */
+
+/**\name Check helpers */
+extern int mock_failures;
+
+#define CHECK(cond)                                                         \
+    do                                                                      \
+    {                                                                       \
+        if (!(cond))                                                        \
+        {                                                                   \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            mock_failures++;                                                \
+        }                                                                   \
+    } while (0)
+
+/**
+ * @brief Simulated sensor behind one pair of bus functions.
+ *
+ * The FIFO is a stream of 12 byte frames. Frame n carries n in accel_x and
+ * byte offsets 2..11 in the remaining fields, so decoded frames show both
+ * their index and their alignment.
+ */
+struct mock_sensor {
+    uint8_t regs[128];          /*< Register file */
+    uint16_t fifo_count;        /*< Bytes in the FIFO */
+    uint32_t fifo_pos;          /*< Stream position of the FIFO head */
+    uint32_t refill;            /*< FIFO reads left that are refilled at once */
+    uint8_t fail_status;        /*< Status returned by injected failures */
+    uint32_t fail_count;        /*< Transfers left to fail */
+    uint32_t reset_polls;       /*< PWR_MGMT_1 reads showing DEVICE_RESET after a reset */
+    uint32_t reset_pending;     /*< Reads left showing DEVICE_RESET */
+    uint32_t transfers;         /*< Transfers attempted */
+    uint32_t fifo_reads;        /*< FIFO_R_W bursts */
+    uint32_t resets;            /*< DEVICE_RESET writes */
+};
+
+extern struct mock_sensor mock_sensors[MOCK_SENSORS];
+extern uint32_t mock_delay_total;
+
+/*!
+ * @brief Clears mock sensor idx and points dev at its bus functions.
+ */
+void mock_bind(struct iam20680_dev *dev, uint8_t idx, uint8_t interface);
+
+/*!
+ * @brief Appends frames to the FIFO of mock sensor idx.
+ */
+void mock_fill_fifo(uint8_t idx, uint16_t frames);
+
+/*!
+ * @brief Injects count failures returning status on mock sensor idx.
+ */
+void mock_fail(uint8_t idx, uint8_t status, uint32_t count);
+
+#endif /* __MOCK_BUS_H */
@@ -0,0 +1,386 @@
+/**
+ * @file    test_iam20680_reactor.c
+ * @brief   Tests for the IAM-20680 epoll reactor, driven by eventfds.
+ *
+ * Build and run from the repository root:
+ *   gcc -Iinc -Itest src/iam20680.c src/iam20680_reactor.c test/mock_bus.c \
+ *       test/test_iam20680_reactor.c -pthread -o test_reactor && ./test_reactor
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "iam20680_reactor.h"
+#include "mock_bus.h"
+
+/**\name Test fixture */
+struct record {
+    uint32_t calls;             /*< Batch callbacks */
+    uint32_t frames;            /*< Frames received */
+    uint32_t misdecoded;        /*< Frames with unexpected contents */
+    uint16_t next_frame;        /*< Expected accel_x of the next frame */
+    uint32_t faults;            /*< Fault callbacks */
+    uint8_t fault_error;        /*< Error passed to the last fault callback */
+    uint8_t remove_on_call;     /*< Remove the sensor from its callback */
+    uint8_t stop_on_call;       /*< Stop the reactor from the callback */
+};
+
+static struct iam20680_reactor reactor;
+static struct iam20680_dev devs[MOCK_SENSORS];
+static struct record records[MOCK_SENSORS];
+static int fds[MOCK_SENSORS];
+
+static void on_batch(struct iam20680_dev *dev, struct iam20680_data *data, uint16_t n_frames, void *user_data)
+{
+    struct record *rec = user_data;
+    uint16_t i;
+
+    rec->calls++;
+    rec->frames += n_frames;
+    for (i = 0; i < n_frames; i++)
+    {
+        if (data[i].accel_x != (int16_t)rec->next_frame || data[i].gyro_z != ((10 << 8) | 11))
+        {
+            rec->misdecoded++;
+        }
+        rec->next_frame++;
+    }
+
+    if (rec->remove_on_call)
+    {
+        iam20680_reactor_remove(&reactor, dev);
+    }
+    if (rec->stop_on_call)
+    {
+        iam20680_reactor_stop(&reactor);
+    }
+}
+
+static void on_fault(struct iam20680_dev *dev, uint8_t error, void *user_data)
+{
+    struct record *rec = user_data;
+
+    (void)dev;
+    rec->faults++;
+    rec->fault_error = error;
+}
+
+static void signal_fd(int fd)
+{
+    uint64_t one = 1;
+
+    CHECK(write(fd, &one, sizeof(one)) == sizeof(one));
+}
+
+static void setup(uint32_t coalesce_ms)
+{
+    uint8_t i;
+
+    memset(records, 0, sizeof(records));
+    CHECK(iam20680_reactor_init(&reactor, coalesce_ms, on_fault) == IAM20680_OK);
+    for (i = 0; i < MOCK_SENSORS; i++)
+    {
+        mock_bind(&devs[i], i, IAM20680_SPI);
+        fds[i] = eventfd(0, 0);
+        CHECK(fds[i] >= 0);
+        CHECK(iam20680_reactor_add(&reactor, &devs[i], fds[i], on_batch, &records[i]) == IAM20680_OK);
+    }
+}
+
+static void teardown(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < MOCK_SENSORS; i++)
+    {
+        iam20680_reactor_remove(&reactor, &devs[i]);
+        close(fds[i]);
+    }
+    CHECK(iam20680_reactor_deinit(&reactor) == IAM20680_OK);
+}
+
+static uint32_t elapsed_ms(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000);
+}
+
+static void *signal_later(void *arg)
+{
+    usleep(5000);
+    signal_fd(*(int *)arg);
+
+    return NULL;
+}
+
+/*!
+ * @brief Interrupts inside the window are drained with one FIFO burst per sensor.
+ */
+static void test_coalesce(void)
+{
+    pthread_t thread;
+
+    setup(50);
+    mock_fill_fifo(0, 10);
+    mock_fill_fifo(1, 3);
+    signal_fd(fds[0]);
+    signal_fd(fds[0]);
+    CHECK(pthread_create(&thread, NULL, signal_later, &fds[1]) == 0);
+
+    CHECK(iam20680_reactor_run_once(&reactor, 1000) == IAM20680_OK);
+    pthread_join(thread, NULL);
+
+    CHECK(records[0].calls == 1);
+    CHECK(records[0].frames == 10);
+    CHECK(records[1].calls == 1);
+    CHECK(records[1].frames == 3);
+    CHECK(records[0].misdecoded == 0 && records[1].misdecoded == 0);
+    CHECK(mock_sensors[0].fifo_reads == 1);
+    CHECK(mock_sensors[1].fifo_reads == 1);
+
+    // Nothing pending, the next iteration times out without dispatching.
+    CHECK(iam20680_reactor_run_once(&reactor, 0) == IAM20680_OK);
+    CHECK(records[0].calls == 1 && records[1].calls == 1);
+    teardown();
+}
+
+/*!
+ * @brief Sensors left pending by the drain cap are drained without a window.
+ */
+static void test_coalesce_capped(void)
+{
+    struct timespec start;
+
+    setup(200);
+    mock_fill_fifo(0, IAM20680_FIFO_FRAMES_MAX);
+    mock_sensors[0].refill = 1000;
+    signal_fd(fds[0]);
+    CHECK(iam20680_reactor_run_once(&reactor, 1000) == IAM20680_OK);
+    CHECK(records[0].calls == IAM20680_REACTOR_DRAIN_PASSES);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    CHECK(iam20680_reactor_run_once(&reactor, -1) == IAM20680_OK);
+    CHECK(elapsed_ms(&start) < 100);
+    CHECK(records[0].calls == 2 * IAM20680_REACTOR_DRAIN_PASSES);
+    teardown();
+}
+
+static void *stop_later(void *arg)
+{
+    (void)arg;
+    usleep(5000);
+    CHECK(iam20680_reactor_stop(&reactor) == IAM20680_OK);
+
+    return NULL;
+}
+
+/*!
+ * @brief iam20680_reactor_stop ends the window early, collected sensors are drained.
+ */
+static void test_coalesce_stop(void)
+{
+    struct timespec start;
+    pthread_t thread;
+
+    setup(1000);
+    mock_fill_fifo(0, 3);
+    signal_fd(fds[0]);
+    CHECK(pthread_create(&thread, NULL, stop_later, NULL) == 0);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    CHECK(iam20680_reactor_run_once(&reactor, 1000) == IAM20680_OK);
+    CHECK(elapsed_ms(&start) < 500);
+    pthread_join(thread, NULL);
+    CHECK(records[0].calls == 1);
+    CHECK(records[0].frames == 3);
+    teardown();
+}
+
+/*!
+ * @brief A full FIFO is drained in batches of IAM20680_FIFO_FRAMES_MAX.
+ */
+static void test_batches(void)
+{
+    setup(0);
+    mock_fill_fifo(0, IAM20680_FIFO_FRAMES_MAX);
+    // The first 255 byte burst is refilled while the batch is read.
+    mock_sensors[0].refill = 1;
+    signal_fd(fds[0]);
+
+    CHECK(iam20680_reactor_run_once(&reactor, 1000) == IAM20680_OK);
+    CHECK(records[0].calls == 2);
+    CHECK(records[0].frames == IAM20680_FIFO_FRAMES_MAX + 255 / IAM20680_FIFO_FRAME_LEN);
+    CHECK(records[0].misdecoded == 0);
+    CHECK(records[1].calls == 0);
+    teardown();
+}
+
+/*!
+ * @brief A sensor refilling its FIFO is capped and serviced again next iteration.
+ */
+static void test_drain_cap(void)
+{
+    setup(0);
+    mock_fill_fifo(0, IAM20680_FIFO_FRAMES_MAX);
+    mock_sensors[0].refill = 1000;
+    mock_fill_fifo(1, 4);
+    signal_fd(fds[0]);
+    signal_fd(fds[1]);
+
+    CHECK(iam20680_reactor_run_once(&reactor, 1000) == IAM20680_OK);
+    CHECK(records[0].calls == IAM20680_REACTOR_DRAIN_PASSES);
+    CHECK(records[1].calls == 1);
+
+    // Still pending, so this returns at once instead of waiting forever.
+    CHECK(iam20680_reactor_run_once(&reactor, -1) == IAM20680_OK);
+    CHECK(records[0].calls == 2 * IAM20680_REACTOR_DRAIN_PASSES);
+    CHECK(records[0].misdecoded == 0);
+    teardown();
+}
+
+/*!
+ * @brief A sensor removed from its own callback is not dispatched again.
+ */
+static void test_remove_from_callback(void)
+{
+    setup(0);
+    records[0].remove_on_call = 1;
+    mock_fill_fifo(0, IAM20680_FIFO_FRAMES_MAX);
+    mock_sensors[0].refill = 1;
+    signal_fd(fds[0]);
+
+    CHECK(iam20680_reactor_run_once(&reactor, 1000) == IAM20680_OK);
+    CHECK(records[0].calls == 1);
+
+    signal_fd(fds[0]);
+    CHECK(iam20680_reactor_run_once(&reactor, 10) == IAM20680_OK);
+    CHECK(records[0].calls == 1);
+    CHECK(iam20680_reactor_remove(&reactor, &devs[0]) != IAM20680_OK);
+    teardown();
+}
+
+/*!
+ * @brief Registration rejects a NULL or already registered sensor.
+ */
+static void test_add_remove(void)
+{
+    setup(0);
+    CHECK(iam20680_reactor_add(&reactor, &devs[0], fds[1], on_batch, &records[0]) != IAM20680_OK);
+    CHECK(iam20680_reactor_add(&reactor, NULL, fds[1], on_batch, &records[0]) != IAM20680_OK);
+    CHECK(iam20680_reactor_remove(&reactor, NULL) != IAM20680_OK);
+    CHECK(reactor.sensors[0].dev == &devs[0] && reactor.sensors[1].dev == &devs[1]);
+    CHECK(reactor.sensors[2].dev == NULL);
+
+    // Both sensors are still serviced.
+    mock_fill_fifo(0, 1);
+    mock_fill_fifo(1, 1);
+    signal_fd(fds[0]);
+    signal_fd(fds[1]);
+    CHECK(iam20680_reactor_run_once(&reactor, 1000) == IAM20680_OK);
+    CHECK(records[0].calls == 1 && records[1].calls == 1);
+    teardown();
+}
+
+/*!
+ * @brief A sensor recovery cannot fix is reported and parked until cleared.
+ */
+static void test_fault(void)
+{
+    struct iam20680_reactor other;
+
+    CHECK(iam20680_reactor_init(&other, 0, NULL) != IAM20680_OK);
+
+    setup(0);
+    mock_fill_fifo(0, 5);
+    mock_fill_fifo(1, 5);
+    mock_fail(0, IAM20680_ERR, 1000);
+    signal_fd(fds[0]);
+    signal_fd(fds[1]);
+
+    CHECK(iam20680_reactor_run_once(&reactor, 1000) == IAM20680_OK);
+    CHECK(records[0].faults == 1);
+    CHECK(records[0].fault_error == IAM20680_ERR);
+    CHECK(records[0].calls == 0);
+    CHECK(records[1].calls == 1);
+    CHECK(records[1].faults == 0);
+
+    // Parked sensors are not touched.
+    mock_fail(0, IAM20680_OK, 0);
+    mock_sensors[0].transfers = 0;
+    signal_fd(fds[0]);
+    CHECK(iam20680_reactor_run_once(&reactor, 10) == IAM20680_OK);
+    CHECK(mock_sensors[0].transfers == 0);
+
+    CHECK(iam20680_reactor_clear_fault(&reactor, NULL) != IAM20680_OK);
+    CHECK(iam20680_reactor_clear_fault(&reactor, &devs[0]) == IAM20680_OK);
+    signal_fd(fds[0]);
+    CHECK(iam20680_reactor_run_once(&reactor, 10) == IAM20680_OK);
+    CHECK(records[0].calls == 1);
+    CHECK(records[0].frames == 5);
+    CHECK(records[0].faults == 1);
+    teardown();
+}
+
+/*!
+ * @brief iam20680_reactor_stop from a callback ends iam20680_reactor_run.
+ */
+static void test_stop(void)
+{
+    setup(0);
+    records[1].stop_on_call = 1;
+    mock_fill_fifo(1, 1);
+    signal_fd(fds[1]);
+
+    CHECK(iam20680_reactor_run(&reactor) == IAM20680_OK);
+    CHECK(records[1].calls == 1);
+    teardown();
+}
+
+static void *stop_now(void *arg)
+{
+    (void)arg;
+    CHECK(iam20680_reactor_stop(&reactor) == IAM20680_OK);
+
+    return NULL;
+}
+
+/*!
+ * @brief A stop issued from another thread before iam20680_reactor_run is kept.
+ */
+static void test_stop_before_run(void)
+{
+    pthread_t thread;
+
+    setup(0);
+    CHECK(pthread_create(&thread, NULL, stop_now, NULL) == 0);
+    pthread_join(thread, NULL);
+
+    mock_fill_fifo(0, 1);
+    signal_fd(fds[0]);
+    CHECK(iam20680_reactor_run(&reactor) == IAM20680_OK);
+    CHECK(records[0].calls == 0);
+    teardown();
+}
+
+int main(void)
+{
+    test_coalesce();
+    test_coalesce_capped();
+    test_coalesce_stop();
+    test_batches();
+    test_drain_cap();
+    test_remove_from_callback();
+    test_add_remove();
+    test_fault();
+    test_stop();
+    test_stop_before_run();
+
+    printf("%s: %d failure(s)\n", __FILE__, mock_failures);
+
+    return mock_failures != 0;
+}
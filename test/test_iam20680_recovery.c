@@ -0,0 +1,242 @@
+/**
+ * @file    test_iam20680_recovery.c
+ * @brief   Tests for IAM-20680 bus retries, FIFO fault detection and recovery.
+ *
+ * Build and run from the repository root:
+ *   gcc -Iinc -Itest src/iam20680.c test/mock_bus.c \
+ *       test/test_iam20680_recovery.c -o test_recovery && ./test_recovery
+ */
+
+#include <string.h>
+#include "mock_bus.h"
+
+static struct iam20680_dev dev;
+static struct mock_sensor *mock = &mock_sensors[0];
+
+/*!
+ * @brief NACKs and timeouts are retried up to IAM20680_BUS_RETRY_MAX times,
+ * generic errors and FIFO bursts are not.
+ */
+static void test_retry_bound(void)
+{
+    uint8_t buff[IAM20680_FIFO_FRAME_LEN];
+
+    mock_bind(&dev, 0, IAM20680_SPI);
+    mock_fail(0, IAM20680_E_BUS_NACK, IAM20680_BUS_RETRY_MAX);
+    CHECK(iam20680_read_regs(IAM20680_WHO_AM_I, buff, 1, &dev) == IAM20680_OK);
+    CHECK(buff[0] == IAM20680_CHIP_ID);
+    CHECK(dev.recovery.bus_nacks == IAM20680_BUS_RETRY_MAX);
+    CHECK(dev.recovery.bus_retries == IAM20680_BUS_RETRY_MAX);
+    CHECK(dev.recovery.bus_errors == 0);
+
+    mock->transfers = 0;
+    mock_fail(0, IAM20680_E_BUS_TIMEOUT, 100);
+    CHECK(iam20680_write_regs(IAM20680_SMPLRT_DIV, buff, 1, &dev) == IAM20680_E_BUS_TIMEOUT);
+    CHECK(mock->transfers == 1 + IAM20680_BUS_RETRY_MAX);
+    CHECK(dev.recovery.bus_timeouts == 1 + IAM20680_BUS_RETRY_MAX);
+    CHECK(dev.recovery.bus_errors == 1);
+
+    mock->transfers = 0;
+    mock_fail(0, IAM20680_ERR, 100);
+    CHECK(iam20680_read_regs(IAM20680_WHO_AM_I, buff, 1, &dev) == IAM20680_ERR);
+    CHECK(mock->transfers == 1);
+
+    mock->transfers = 0;
+    mock_fail(0, IAM20680_E_BUS_TIMEOUT, 100);
+    CHECK(iam20680_read_regs(IAM20680_FIFO_R_W, buff, sizeof(buff), &dev) == IAM20680_E_BUS_TIMEOUT);
+    CHECK(mock->transfers == 1);
+}
+
+/*!
+ * @brief A FIFO at full depth is reported as overflow and nothing is read.
+ */
+static void test_fifo_overflow(void)
+{
+    struct iam20680_data data[IAM20680_FIFO_FRAMES_MAX];
+    uint16_t n_frames = IAM20680_FIFO_FRAMES_MAX;
+
+    mock_bind(&dev, 0, IAM20680_SPI);
+    mock->fifo_count = IAM20680_FIFO_SIZE;
+    CHECK(iam20680_get_fifo_data(data, &n_frames, &dev) == IAM20680_E_FIFO_OVERFLOW);
+    CHECK(n_frames == 0);
+    CHECK(mock->fifo_reads == 0);
+    CHECK(dev.recovery.fifo_overflows == 1);
+
+    CHECK(iam20680_recover(IAM20680_E_FIFO_OVERFLOW, &dev) == IAM20680_OK);
+    CHECK(mock->fifo_count == 0);
+    CHECK(dev.recovery.fifo_resets == 1);
+    CHECK(mock->regs[IAM20680_USER_CTRL] == 0x00);
+
+    // An enabled FIFO is enabled again, other USER_CTRL bits are kept.
+    mock->regs[IAM20680_USER_CTRL] = 0x50;
+    CHECK(iam20680_recover(IAM20680_E_FIFO_OVERFLOW, &dev) == IAM20680_OK);
+    CHECK(mock->regs[IAM20680_USER_CTRL] == 0x50);
+    CHECK(dev.recovery.fifo_resets == 2);
+
+    // FIFO_OFLOW_INT is reported below full depth and cleared by the read.
+    mock_fill_fifo(0, 4);
+    mock->regs[IAM20680_INT_STATUS] = 0x10;
+    n_frames = IAM20680_FIFO_FRAMES_MAX;
+    CHECK(iam20680_get_fifo_data(data, &n_frames, &dev) == IAM20680_E_FIFO_OVERFLOW);
+    CHECK(n_frames == 0);
+    CHECK(mock->fifo_reads == 0);
+    CHECK(dev.recovery.fifo_overflows == 2);
+    CHECK(mock->regs[IAM20680_INT_STATUS] == 0x00);
+}
+
+/*!
+ * @brief A partial frame at the head is detected and discarded.
+ */
+static void test_fifo_misalignment(void)
+{
+    struct iam20680_data data[IAM20680_FIFO_FRAMES_MAX];
+    uint16_t n_frames = IAM20680_FIFO_FRAMES_MAX;
+
+    // 7 bytes of frame 0 were consumed by a cut-short burst.
+    mock_bind(&dev, 0, IAM20680_SPI);
+    mock_fill_fifo(0, 4);
+    mock->fifo_pos = 7;
+    mock->fifo_count -= 7;
+    CHECK(iam20680_get_fifo_data(data, &n_frames, &dev) == IAM20680_E_FIFO_ALIGN);
+    CHECK(n_frames == 0);
+    CHECK(dev.recovery.fifo_misalignments == 1);
+
+    CHECK(iam20680_recover(IAM20680_E_FIFO_ALIGN, &dev) == IAM20680_OK);
+    CHECK(mock->fifo_pos == IAM20680_FIFO_FRAME_LEN);
+    CHECK(mock->fifo_count == 3 * IAM20680_FIFO_FRAME_LEN);
+    CHECK(dev.recovery.fifo_resyncs == 1);
+    CHECK(dev.recovery.fifo_resets == 0);
+
+    n_frames = IAM20680_FIFO_FRAMES_MAX;
+    CHECK(iam20680_get_fifo_data(data, &n_frames, &dev) == IAM20680_OK);
+    CHECK(n_frames == 3);
+    CHECK(data[0].accel_x == 1 && data[2].accel_x == 3);
+    CHECK(data[0].gyro_z == ((10 << 8) | 11));
+}
+
+/*!
+ * @brief Each class takes its own cheapest fix and full resets are left to
+ * the caller.
+ */
+static void test_recover_escalation(void)
+{
+    mock_bind(&dev, 0, IAM20680_SPI);
+    mock_fill_fifo(0, 2);
+
+    // Aligned FIFO, a NACK realigns nothing and counts no resync.
+    CHECK(iam20680_recover(IAM20680_E_BUS_NACK, &dev) == IAM20680_OK);
+    CHECK(dev.recovery.fifo_resyncs == 0);
+    CHECK(dev.recovery.fifo_resets == 0);
+    CHECK(mock->fifo_count == 2 * IAM20680_FIFO_FRAME_LEN);
+
+    // Realign cannot fix a FIFO at full depth, a timeout falls back to a reset.
+    mock->fifo_count = IAM20680_FIFO_SIZE;
+    CHECK(iam20680_recover(IAM20680_E_BUS_TIMEOUT, &dev) == IAM20680_OK);
+    CHECK(dev.recovery.fifo_resets == 1);
+    CHECK(mock->fifo_count == 0);
+
+    // A NACK on a full FIFO falls back to a reset too.
+    mock->fifo_count = IAM20680_FIFO_SIZE;
+    CHECK(iam20680_recover(IAM20680_E_BUS_NACK, &dev) == IAM20680_OK);
+    CHECK(dev.recovery.fifo_resets == 2);
+    CHECK(mock->fifo_count == 0);
+
+    // Dead bus and reset timeouts need iam20680_reinit, recover never delays.
+    mock_delay_total = 0;
+    mock_fail(0, IAM20680_E_BUS_NACK, 1000);
+    CHECK(iam20680_recover(IAM20680_E_BUS_TIMEOUT, &dev) != IAM20680_OK);
+    mock_fail(0, IAM20680_OK, 0);
+    mock->transfers = 0;
+    CHECK(iam20680_recover(IAM20680_E_RESET_TIMEOUT | IAM20680_E_BUS_NACK, &dev) != IAM20680_OK);
+    CHECK(mock->transfers == 0);
+    CHECK(mock->resets == 0);
+    CHECK(mock_delay_total == 0);
+    CHECK(dev.recovery.full_resets == 0);
+}
+
+/*!
+ * @brief iam20680_reinit wakes the device and restores the captured configuration.
+ */
+static void test_reinit(void)
+{
+    mock_bind(&dev, 0, IAM20680_SPI);
+    CHECK(iam20680_reinit(&dev) == IAM20680_ERR);
+    CHECK(mock->resets == 0);
+
+    CHECK(iam20680_init(&dev) == IAM20680_OK);
+    CHECK(dev.settings.valid);
+    mock_fill_fifo(0, 3);
+
+    CHECK(iam20680_reinit(&dev) == IAM20680_OK);
+    CHECK(mock->resets == 1);
+    CHECK((mock->regs[IAM20680_PWR_MGMT_1] & 0x40) == 0x00);    // SLEEP
+    CHECK((mock->regs[IAM20680_PWR_MGMT_1] & 0x07) == 0x01);    // CLKSEL
+    CHECK((mock->regs[IAM20680_USER_CTRL] & 0x10) == 0x10);     // I2C_IF_DIS
+    CHECK((mock->regs[IAM20680_USER_CTRL] & 0x40) == 0x40);     // FIFO_EN
+    CHECK(mock->regs[IAM20680_SMPLRT_DIV] == 0x09);
+    CHECK(mock->regs[IAM20680_INT_ENABLE] == 0x01);
+    CHECK(mock->regs[IAM20680_FIFO_EN] == 0x78);
+    CHECK(mock->regs[IAM20680_GYRO_CONFIG] == dev.settings.gyro_config);
+    CHECK(mock->regs[IAM20680_ACCEL_CONFIG2] == dev.settings.accel_config2);
+    CHECK(mock->fifo_count == 0);
+    CHECK(dev.recovery.full_resets == 1);
+}
+
+/*!
+ * @brief Only a fully successful init replaces the captured configuration.
+ */
+static void test_settings_capture(void)
+{
+    struct iam20680_settings settings;
+
+    // The bus fails once, every capture read still succeeds.
+    mock_bind(&dev, 0, IAM20680_SPI);
+    mock_fail(0, IAM20680_ERR, 1);
+    CHECK(iam20680_init(&dev) != IAM20680_OK);
+    CHECK(!dev.settings.valid);
+
+    CHECK(iam20680_init(&dev) == IAM20680_OK);
+    CHECK(dev.settings.valid);
+    settings = dev.settings;
+
+    mock->reset_polls = 1000;
+    CHECK(iam20680_init_simple(&dev) & IAM20680_E_RESET_TIMEOUT);
+    CHECK(memcmp(&dev.settings, &settings, sizeof(settings)) == 0);
+}
+
+/*!
+ * @brief DEVICE_RESET polling is bounded and its class survives OR'd statuses.
+ */
+static void test_reset_timeout(void)
+{
+    uint8_t status;
+
+    mock_bind(&dev, 0, IAM20680_SPI);
+    mock->reset_polls = 1000;
+    mock_delay_total = 0;
+
+    status = iam20680_init_simple(&dev);
+    CHECK(status & IAM20680_E_RESET_TIMEOUT);
+    CHECK(mock_delay_total == 100 + IAM20680_RESET_POLL_MAX);
+
+    mock->reset_polls = 1000;
+    mock_fail(0, IAM20680_E_BUS_NACK, 1 + IAM20680_BUS_RETRY_MAX);
+    status = iam20680_init2(&dev);
+    CHECK(status & IAM20680_E_BUS_NACK);
+    CHECK((status & ~(IAM20680_E_BUS_NACK | IAM20680_E_RESET_TIMEOUT)) == 0);
+}
+
+int main(void)
+{
+    test_retry_bound();
+    test_fifo_overflow();
+    test_fifo_misalignment();
+    test_recover_escalation();
+    test_reinit();
+    test_settings_capture();
+    test_reset_timeout();
+
+    printf("%s: %d failure(s)\n", __FILE__, mock_failures);
+
+    return mock_failures != 0;
+}